@@ -2,9 +2,34 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "graph.h"
 
+/* Statistics counters, compiled out without GRAPH_STATS */
+#ifdef GRAPH_STATS
+#define graph_stat_add(graph, counter, n) ((graph)->stats.counter += (n))
+#else
+#define graph_stat_add(graph, counter, n) do { } while (0)
+#endif
+
+#define graph_stat_inc(graph, counter) graph_stat_add(graph, counter, 1)
+
+/* Trace hooks, compiled out without GRAPH_TRACE */
+#ifdef GRAPH_TRACE
+#define graph_trace(graph, op, enter)                                   \
+    do {                                                                \
+        if ((graph)->trace != NULL) {                                   \
+            (graph)->trace((graph), (op), (enter), (graph)->trace_ctx); \
+        }                                                               \
+    } while (0)
+#else
+#define graph_trace(graph, op, enter) do { } while (0)
+#endif
+
+#define graph_trace_enter(graph, op) graph_trace(graph, op, true)
+#define graph_trace_exit(graph, op) graph_trace(graph, op, false)
+
 /* Markers operations */
 void set_marker(struct graph* graph,
                 uint32 id,
@@ -17,6 +42,8 @@ void set_marker(struct graph* graph,
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_SET_MARKER);
+
     new_elem = malloc(sizeof(struct marked_elem));
     INIT_LIST_ENTRY(&new_elem->entry);
 
@@ -24,6 +51,10 @@ void set_marker(struct graph* graph,
     new_elem->markers = markers;
     new_elem->vertex_or_edge = vertex_or_edge;
     markers[id] = new_elem;
+
+    graph_stat_inc(graph, markers_set);
+    graph_stat_add(graph, bytes_allocated, sizeof(struct marked_elem));
+    graph_trace_exit(graph, GRAPH_OP_SET_MARKER);
 }
 
 void unset_marker(struct graph* graph,
@@ -36,23 +67,34 @@ void unset_marker(struct graph* graph,
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_UNSET_MARKER);
+
     list_del(&elem->entry);
     elem->markers = NULL;
     markers[id] = NULL;
 
     free(elem);
+
+    graph_stat_inc(graph, markers_unset);
+    graph_stat_add(graph, bytes_freed, sizeof(struct marked_elem));
+    graph_trace_exit(graph, GRAPH_OP_UNSET_MARKER);
 }
 
 uint32 alloc_marker(struct graph* graph) {
     uint32 id = INVALID_MARKER;
 
+    graph_trace_enter(graph, GRAPH_OP_ALLOC_MARKER);
+
     for (id = 0; id < MARKER_COUNT; ++id) {
         if (!graph->markers[id].allocated) {
             graph->markers[id].allocated = true;
+            graph_stat_inc(graph, markers_allocated);
             break;
         }
     }
 
+    graph_trace_exit(graph, GRAPH_OP_ALLOC_MARKER);
+
     return id;
 }
 
@@ -64,11 +106,16 @@ void free_marker(struct graph* graph, uint32 id) {
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_FREE_MARKER);
+
     list_for_each_entry_safe(elem, _elem, &graph->markers[id].marked, entry) {
         unset_marker(graph, id, elem->markers);
     }
 
     graph->markers[id].allocated = false;
+
+    graph_stat_inc(graph, markers_freed);
+    graph_trace_exit(graph, GRAPH_OP_FREE_MARKER);
 }
 
 bool check_marker(struct marked_elem** markers, uint32 id) {
@@ -106,6 +153,8 @@ void print_vertex(struct vertex* vertex, unsigned char indent) {
 
     printf("%*sVertex:\n", indent, "");
     printf("%*sdata = %d\n", indent + 4, "", vertex->data);
+    printf("%*sin_degree = %u\n", indent + 4, "", vertex->in_degree);
+    printf("%*sout_degree = %u\n", indent + 4, "", vertex->out_degree);
 
     printf("%*sinput:%s\n", indent + 4, "",
            list_is_empty(&vertex->input) ? "EMPTY" : "");
@@ -187,6 +236,286 @@ void print_graph(struct graph* graph, unsigned char indent) {
     }
 }
 
+/* Export operations */
+
+/* Size of the exporter output buffer */
+#define EXPORT_BUF_SIZE (64 * 1024)
+
+struct export_buf {
+    FILE* file; /* Output stream */
+    size_t len; /* Number of bytes pending in data */
+    bool failed; /* If writing to the stream failed */
+    char data[EXPORT_BUF_SIZE]; /* Pending output */
+};
+
+static void export_flush(struct export_buf* buf) {
+    if ((buf->len != 0) && !buf->failed) {
+        if (fwrite(buf->data, 1, buf->len, buf->file) != buf->len) {
+            buf->failed = true;
+        }
+    }
+
+    buf->len = 0;
+}
+
+static inline void export_str(struct export_buf* buf,
+                              const char* str,
+                              size_t len) {
+    if (buf->len + len > EXPORT_BUF_SIZE) {
+        export_flush(buf);
+    }
+
+    /* String doesn't fit into the buffer at all, write it directly */
+    if (len > EXPORT_BUF_SIZE) {
+        if (!buf->failed && (fwrite(str, 1, len, buf->file) != len)) {
+            buf->failed = true;
+        }
+        return;
+    }
+
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+}
+
+/* Export string literal without strlen() */
+#define export_lit(buf, lit) export_str(buf, lit, sizeof(lit) - 1)
+
+static inline void export_uint(struct export_buf* buf, uint32 value) {
+    char digits[10]; /* Enough for UINT_MAX */
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    export_str(buf, digits + pos, sizeof(digits) - pos);
+}
+
+/*
+ * Vertex data is only a payload and may repeat, so vertexes are identified
+ * by their address in every export format
+ */
+static inline void export_vertex_id(struct export_buf* buf,
+                                    struct vertex* vertex) {
+    static const char hex[] = "0123456789abcdef";
+    char digits[1 + 2 * sizeof(uint64)]; /* 'v' and hex digits */
+    uint64 value = (uint64)(size_t)vertex;
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = hex[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    digits[--pos] = 'v';
+
+    export_str(buf, digits + pos, sizeof(digits) - pos);
+}
+
+/*
+ * INVALID_MARKER passed as filter exports every element. Otherwise only
+ * marked vertexes are exported, and an edge is exported only if it and both
+ * its source and destination vertexes are marked, so the output never
+ * references a vertex it doesn't contain.
+ */
+static inline bool export_vertex_passes(struct vertex* vertex, uint32 marker) {
+    return (marker == INVALID_MARKER) || check_marker_vertex(vertex, marker);
+}
+
+static inline bool export_edge_passes(struct edge* edge, uint32 marker) {
+    return (marker == INVALID_MARKER) ||
+           (check_marker_edge(edge, marker) &&
+            export_vertex_passes(edge->src, marker) &&
+            export_vertex_passes(edge->dst, marker));
+}
+
+/* Format graph into the export buffer */
+typedef void (*export_fn)(struct export_buf* buf,
+                          struct graph* graph,
+                          uint32 marker);
+
+/* Common exporter body: allocate buffer, format graph, flush and free */
+static int export_graph(struct graph* graph,
+                        FILE* file,
+                        uint32 marker,
+                        export_fn format) {
+    struct export_buf* buf = NULL;
+    int err = -1;
+
+    if ((graph == NULL) || (file == NULL)) {
+        goto exit;
+    }
+
+    /* Filter must be INVALID_MARKER or an allocated marker */
+    if ((marker != INVALID_MARKER) &&
+        ((marker >= MARKER_COUNT) || !graph->markers[marker].allocated)) {
+        goto exit;
+    }
+
+    buf = malloc(sizeof(struct export_buf));
+    if (buf == NULL) {
+        goto exit;
+    }
+    graph_stat_add(graph, bytes_allocated, sizeof(struct export_buf));
+
+    buf->file = file;
+    buf->len = 0;
+    buf->failed = false;
+
+    format(buf, graph, marker);
+
+    export_flush(buf);
+    err = buf->failed ? -1 : 0;
+
+    free(buf);
+    graph_stat_add(graph, bytes_freed, sizeof(struct export_buf));
+
+exit:
+    return err;
+}
+
+static void export_dot(struct export_buf* buf,
+                       struct graph* graph,
+                       uint32 marker) {
+    struct vertex* vertex = NULL;
+    struct edge* edge = NULL;
+
+    export_lit(buf, "digraph G {\n");
+
+    list_for_each_entry(vertex, &graph->vertexes, graph_entry) {
+        if (export_vertex_passes(vertex, marker)) {
+            export_lit(buf, "    ");
+            export_vertex_id(buf, vertex);
+            export_lit(buf, " [label=\"");
+            export_uint(buf, vertex->data);
+            export_lit(buf, "\"];\n");
+        }
+    }
+
+    list_for_each_entry(edge, &graph->edges, graph_entry) {
+        if (export_edge_passes(edge, marker)) {
+            export_lit(buf, "    ");
+            export_vertex_id(buf, edge->src);
+            export_lit(buf, " -> ");
+            export_vertex_id(buf, edge->dst);
+            export_lit(buf, ";\n");
+        }
+    }
+
+    export_lit(buf, "}\n");
+}
+
+static void export_edge_list(struct export_buf* buf,
+                             struct graph* graph,
+                             uint32 marker) {
+    struct edge* edge = NULL;
+
+    list_for_each_entry(edge, &graph->edges, graph_entry) {
+        if (export_edge_passes(edge, marker)) {
+            export_vertex_id(buf, edge->src);
+            export_lit(buf, " ");
+            export_vertex_id(buf, edge->dst);
+            export_lit(buf, "\n");
+        }
+    }
+}
+
+static void export_json(struct export_buf* buf,
+                        struct graph* graph,
+                        uint32 marker) {
+    struct vertex* vertex = NULL;
+    struct edge* edge = NULL;
+    bool first = true;
+
+    export_lit(buf, "{\"vertexes\":[");
+
+    list_for_each_entry(vertex, &graph->vertexes, graph_entry) {
+        if (export_vertex_passes(vertex, marker)) {
+            if (!first) {
+                export_lit(buf, ",");
+            }
+            first = false;
+            export_lit(buf, "{\"id\":\"");
+            export_vertex_id(buf, vertex);
+            export_lit(buf, "\",\"data\":");
+            export_uint(buf, vertex->data);
+            export_lit(buf, "}");
+        }
+    }
+
+    export_lit(buf, "],\"edges\":[");
+    first = true;
+
+    list_for_each_entry(edge, &graph->edges, graph_entry) {
+        if (export_edge_passes(edge, marker)) {
+            if (!first) {
+                export_lit(buf, ",");
+            }
+            first = false;
+            export_lit(buf, "[\"");
+            export_vertex_id(buf, edge->src);
+            export_lit(buf, "\",\"");
+            export_vertex_id(buf, edge->dst);
+            export_lit(buf, "\"]");
+        }
+    }
+
+    export_lit(buf, "]}\n");
+}
+
+int export_graph_dot(struct graph* graph, FILE* file, uint32 marker) {
+    return export_graph(graph, file, marker, export_dot);
+}
+
+int export_graph_edge_list(struct graph* graph, FILE* file, uint32 marker) {
+    return export_graph(graph, file, marker, export_edge_list);
+}
+
+int export_graph_json(struct graph* graph, FILE* file, uint32 marker) {
+    return export_graph(graph, file, marker, export_json);
+}
+
+#ifdef GRAPH_STATS
+/* Statistics operations */
+void collect_graph_stats(struct graph* graph, struct graph_stats* stats) {
+    struct vertex* vertex = NULL;
+
+    *stats = graph->stats;
+    stats->max_degree = 0;
+
+    list_for_each_entry(vertex, &graph->vertexes, graph_entry) {
+        if (vertex_degree(vertex) > stats->max_degree) {
+            stats->max_degree = vertex_degree(vertex);
+        }
+    }
+}
+
+void print_graph_stats(struct graph* graph, unsigned char indent) {
+    struct graph_stats stats;
+
+    if (graph == NULL) {
+        return;
+    }
+
+    collect_graph_stats(graph, &stats);
+
+    printf("%*sStats:\n", indent, "");
+    printf("%*svertexes: created = %llu, destroyed = %llu\n", indent + 4, "",
+           stats.vertexes_created, stats.vertexes_destroyed);
+    printf("%*sedges: created = %llu, destroyed = %llu, redirected = %llu\n",
+           indent + 4, "", stats.edges_created, stats.edges_destroyed,
+           stats.edges_redirected);
+    printf("%*smarkers: allocated = %llu, freed = %llu, set = %llu, "
+           "unset = %llu\n", indent + 4, "", stats.markers_allocated,
+           stats.markers_freed, stats.markers_set, stats.markers_unset);
+    printf("%*sbytes: allocated = %llu, freed = %llu\n", indent + 4, "",
+           stats.bytes_allocated, stats.bytes_freed);
+    printf("%*smax_degree = %llu\n", indent + 4, "", stats.max_degree);
+
+    return;
+}
+#endif /* GRAPH_STATS */
+
 struct edge* create_edge(struct graph* graph,
                          struct vertex* src,
                          struct vertex* dst) {
@@ -196,10 +525,12 @@ struct edge* create_edge(struct graph* graph,
         goto exit;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_CREATE_EDGE);
+
     /* Allocate memory for the edge */
     edge = malloc(sizeof(struct edge));
     if (edge == NULL) {
-        goto exit;
+        goto trace_exit;
     }
 
     /* Initialize all edge's data */
@@ -208,6 +539,7 @@ struct edge* create_edge(struct graph* graph,
     INIT_LIST_ENTRY(&edge->graph_entry);
     edge->src = src;
     edge->dst = dst;
+    memset(edge->markers, 0, sizeof(edge->markers));
 
     /* Add edge to the graph */
     list_add_tail(&edge->graph_entry, &graph->edges);
@@ -215,9 +547,17 @@ struct edge* create_edge(struct graph* graph,
 
     /* Add edge to the source vertex */
     list_add_tail(&edge->output_entry, &src->output);
+    src->out_degree += 1;
 
     /* Add edge to the destination vertex */
     list_add_tail(&edge->input_entry, &dst->input);
+    dst->in_degree += 1;
+
+    graph_stat_inc(graph, edges_created);
+    graph_stat_add(graph, bytes_allocated, sizeof(struct edge));
+
+trace_exit:
+    graph_trace_exit(graph, GRAPH_OP_CREATE_EDGE);
 
 exit:
     return edge;
@@ -226,6 +566,8 @@ exit:
 struct vertex* create_vertex(struct graph* graph, unsigned int data) {
     struct vertex* vertex = NULL;
 
+    graph_trace_enter(graph, GRAPH_OP_CREATE_VERTEX);
+
     /* Allocate memory for the vertex */
     vertex = malloc(sizeof(struct vertex));
     if (vertex == NULL) {
@@ -237,12 +579,20 @@ struct vertex* create_vertex(struct graph* graph, unsigned int data) {
     vertex->data = data;
     INIT_LIST_HEAD(&vertex->output);
     INIT_LIST_ENTRY(&vertex->graph_entry);
+    vertex->in_degree = 0;
+    vertex->out_degree = 0;
+    memset(vertex->markers, 0, sizeof(vertex->markers));
 
     /* Add vertex to the graph */
     list_add_tail(&vertex->graph_entry, &graph->vertexes);
     graph->vertexes_num += 1;
 
+    graph_stat_inc(graph, vertexes_created);
+    graph_stat_add(graph, bytes_allocated, sizeof(struct vertex));
+
 exit:
+    graph_trace_exit(graph, GRAPH_OP_CREATE_VERTEX);
+
     return vertex;
 }
 
@@ -268,6 +618,18 @@ struct graph* create_graph(void) {
         graph->markers[i].allocated = false;
     }
 
+#ifdef GRAPH_STATS
+    /* Reset statistics, the graph itself is accounted too */
+    memset(&graph->stats, 0, sizeof(graph->stats));
+    graph_stat_add(graph, bytes_allocated, sizeof(struct graph));
+#endif
+
+#ifdef GRAPH_TRACE
+    /* Tracing is disabled until set_graph_trace() */
+    graph->trace = NULL;
+    graph->trace_ctx = NULL;
+#endif
+
 exit:
     return graph;
 }
@@ -279,15 +641,19 @@ void destroy_edge(struct graph* graph, struct edge* edge) {
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_DESTROY_EDGE);
+
     /* Unset all markers */
     for (i = 0; i < MARKER_COUNT; ++i) {
         unset_marker(graph, i, edge->markers);
     }
 
-    /* NULL source vertex */
+    /* Update degrees and NULL source vertex */
+    edge->src->out_degree -= 1;
     edge->src = NULL;
 
-    /* NULL destination vertex */
+    /* Update degrees and NULL destination vertex */
+    edge->dst->in_degree -= 1;
     edge->dst = NULL;
 
     /* Delete edge from the vertex input list */
@@ -303,6 +669,10 @@ void destroy_edge(struct graph* graph, struct edge* edge) {
     /* Free memory */
     free(edge);
 
+    graph_stat_inc(graph, edges_destroyed);
+    graph_stat_add(graph, bytes_freed, sizeof(struct edge));
+    graph_trace_exit(graph, GRAPH_OP_DESTROY_EDGE);
+
     return;
 }
 
@@ -315,6 +685,8 @@ void destroy_vertex(struct graph* graph, struct vertex* vertex) {
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_DESTROY_VERTEX);
+
     /* Unset all markers */
     for (i = 0; i < MARKER_COUNT; ++i) {
         unset_marker(graph, i, vertex->markers);
@@ -340,6 +712,10 @@ void destroy_vertex(struct graph* graph, struct vertex* vertex) {
     /* Free memory */
     free(vertex);
 
+    graph_stat_inc(graph, vertexes_destroyed);
+    graph_stat_add(graph, bytes_freed, sizeof(struct vertex));
+    graph_trace_exit(graph, GRAPH_OP_DESTROY_VERTEX);
+
     return;
 }
 
@@ -354,6 +730,8 @@ void destroy_graph(struct graph* graph) {
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_DESTROY_GRAPH);
+
     /* Destroy all markers */
     for (i = 0; i < MARKER_COUNT; ++i) {
         free_marker(graph, i);
@@ -369,36 +747,76 @@ void destroy_graph(struct graph* graph) {
         destroy_vertex(graph, vertex);
     }
 
+    /* Graph memory is about to be freed, so report exit now */
+    graph_trace_exit(graph, GRAPH_OP_DESTROY_GRAPH);
+
     /* Free graph memory */
     free(graph);
 }
 
-void redirect_edge(struct edge* edge,
+void redirect_edge(struct graph* graph,
+                   struct edge* edge,
                    struct vertex* new_src,
                    struct vertex* new_dst) {
-    if (edge == NULL) {
+    if ((graph == NULL) || (edge == NULL)) {
         return;
     }
 
+    graph_trace_enter(graph, GRAPH_OP_REDIRECT_EDGE);
+
     if (new_src != NULL) {
         /* Delete edge from the old source vertex output list */
         list_del(&edge->output_entry);
+        edge->src->out_degree -= 1;
 
         /* Add edge to the new source vertex output list */
         list_add_tail(&edge->output_entry, &new_src->output);
+        new_src->out_degree += 1;
         edge->src = new_src;
     }
 
     if (new_dst != NULL) {
         /* Delete edge from the old destination vertex input list */
         list_del(&edge->input_entry);
+        edge->dst->in_degree -= 1;
 
         /* Add edge to the new destination vertex input list */
         list_add_tail(&edge->input_entry, &new_dst->input);
+        new_dst->in_degree += 1;
         edge->dst = new_dst;
     }
+
+    if ((new_src != NULL) || (new_dst != NULL)) {
+        graph_stat_inc(graph, edges_redirected);
+    }
+    graph_trace_exit(graph, GRAPH_OP_REDIRECT_EDGE);
+}
+
+#ifdef GRAPH_TRACE
+/* Tracing operations */
+void set_graph_trace(struct graph* graph, graph_trace_cb trace, void* ctx) {
+    graph->trace = trace;
+    graph->trace_ctx = ctx;
 }
 
+static const char* const graph_op_names[] = {
+    [GRAPH_OP_CREATE_VERTEX] = "create_vertex",
+    [GRAPH_OP_DESTROY_VERTEX] = "destroy_vertex",
+    [GRAPH_OP_CREATE_EDGE] = "create_edge",
+    [GRAPH_OP_DESTROY_EDGE] = "destroy_edge",
+    [GRAPH_OP_REDIRECT_EDGE] = "redirect_edge",
+    [GRAPH_OP_DESTROY_GRAPH] = "destroy_graph",
+    [GRAPH_OP_ALLOC_MARKER] = "alloc_marker",
+    [GRAPH_OP_FREE_MARKER] = "free_marker",
+    [GRAPH_OP_SET_MARKER] = "set_marker",
+    [GRAPH_OP_UNSET_MARKER] = "unset_marker",
+};
+
+void print_trace(struct graph* graph, enum graph_op op, bool enter, void* ctx) {
+    printf("Trace: %s %s\n", enter ? "enter" : "exit", graph_op_names[op]);
+}
+#endif /* GRAPH_TRACE */
+
 int main(int argc, char** argv) {
     struct graph* graph = NULL;
     struct vertex* vertex_1 = NULL;
@@ -420,6 +838,10 @@ int main(int argc, char** argv) {
         goto fail_create_graph;
     }
 
+#ifdef GRAPH_TRACE
+    set_graph_trace(graph, print_trace, NULL);
+#endif
+
     vertex_1 = create_vertex(graph, 1);
     if (vertex_1 == NULL) {
         goto destroy_graph_due_to_fail;
@@ -475,7 +897,7 @@ int main(int argc, char** argv) {
 
     printf("Redirect edge(1, 6) to edge(1, 1):\n");
     print_edge(edge_1_6, 0);
-    redirect_edge(edge_1_6, NULL, vertex_1);
+    redirect_edge(graph, edge_1_6, NULL, vertex_1);
     printf("Graph after redirection:\n");
     print_graph(graph, 0);
 
@@ -558,6 +980,24 @@ int main(int argc, char** argv) {
     printf("Graph after free marker_1\n");
     print_graph(graph, 0);
 
+    printf("Export graph to DOT:\n");
+    export_graph_dot(graph, stdout, INVALID_MARKER);
+    printf("Export graph to edge list:\n");
+    export_graph_edge_list(graph, stdout, INVALID_MARKER);
+    printf("Export graph to JSON:\n");
+    export_graph_json(graph, stdout, INVALID_MARKER);
+    printf("Set vertex 6 with marker 0\n");
+    set_marker_vertex(graph, vertex_6, marker_0);
+    printf("Export graph marked with marker 0 to DOT:\n");
+    export_graph_dot(graph, stdout, marker_0);
+    printf("Export graph marked with marker 0 to JSON:\n");
+    export_graph_json(graph, stdout, marker_0);
+
+#ifdef GRAPH_STATS
+    printf("Graph statistics:\n");
+    print_graph_stats(graph, 0);
+#endif
+
     err = 0;
 
 destroy_graph_due_to_fail:
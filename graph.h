@@ -21,12 +21,56 @@ struct marked_elem {
     bool vertex_or_edge; /* TRUE - vertex, FALSE - edge */
 };
 
+/* Graph operations reported to the trace callback */
+enum graph_op {
+    GRAPH_OP_CREATE_VERTEX,
+    GRAPH_OP_DESTROY_VERTEX,
+    GRAPH_OP_CREATE_EDGE,
+    GRAPH_OP_DESTROY_EDGE,
+    GRAPH_OP_REDIRECT_EDGE,
+    GRAPH_OP_DESTROY_GRAPH,
+    GRAPH_OP_ALLOC_MARKER,
+    GRAPH_OP_FREE_MARKER,
+    GRAPH_OP_SET_MARKER,
+    GRAPH_OP_UNSET_MARKER,
+};
+
+struct graph;
+
+/* Called on enter (TRUE) and on exit (FALSE) of every graph operation */
+typedef void (*graph_trace_cb)(struct graph* graph,
+                               enum graph_op op,
+                               bool enter,
+                               void* ctx);
+
+struct graph_stats {
+    uint64 vertexes_created; /* Number of created vertexes */
+    uint64 vertexes_destroyed; /* Number of destroyed vertexes */
+    uint64 edges_created; /* Number of created edges */
+    uint64 edges_destroyed; /* Number of destroyed edges */
+    uint64 edges_redirected; /* Number of redirected edges */
+    uint64 markers_allocated; /* Number of allocated markers */
+    uint64 markers_freed; /* Number of freed markers */
+    uint64 markers_set; /* Number of set markers */
+    uint64 markers_unset; /* Number of unset markers */
+    uint64 bytes_allocated; /* Bytes allocated for graph elements */
+    uint64 bytes_freed; /* Bytes freed for graph elements */
+    uint64 max_degree; /* Max vertex degree, filled by collect_graph_stats */
+};
+
 struct graph {
     struct list_head vertexes; /* All vertexes */
     struct list_head edges; /* All edges */
     unsigned int vertexes_num; /* Number of vertexes */
     unsigned int edges_num; /* Number of edges */
     struct marker_desc markers[MARKER_COUNT]; /* All available markers */
+#ifdef GRAPH_STATS
+    struct graph_stats stats; /* Operations statistics */
+#endif
+#ifdef GRAPH_TRACE
+    graph_trace_cb trace; /* Trace callback, NULL if tracing is disabled */
+    void* trace_ctx; /* Context passed to the trace callback */
+#endif
 };
 
 struct vertex {
@@ -34,6 +78,8 @@ struct vertex {
     unsigned int data; /* Data accosiated with the vertex */
     struct list_head output; /* Output edges */
     struct list_head graph_entry; /* Entry in graph vertexes list */
+    unsigned int in_degree; /* Number of input edges */
+    unsigned int out_degree; /* Number of output edges */
     struct marked_elem* markers[MARKER_COUNT]; /* All markers */
 };
 
@@ -50,6 +96,10 @@ struct edge {
 #define markers_owner(ptr, type) \
     container_of((struct marked_elem* const(*)[MARKER_COUNT])ptr, type, markers)
 
+#define vertex_in_degree(vertex) ((vertex)->in_degree)
+#define vertex_out_degree(vertex) ((vertex)->out_degree)
+#define vertex_degree(vertex) ((vertex)->in_degree + (vertex)->out_degree)
+
 #define set_marker_vertex(graph, vertex, id) set_marker(graph, id, (vertex)->markers, true)
 #define unset_marker_vertex(graph, vertex, id) unset_marker(graph, id, (vertex)->markers)
 #define check_marker_vertex(vertex, id) check_marker((vertex)->markers, id)